@@ -5,6 +5,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
+#ifdef JSON_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef JSON_WITH_ZSTD
+#include <zstd.h>
+#endif
 
 extern unsigned char json_start[];
 extern unsigned char json_end[];
@@ -31,6 +38,7 @@ struct json_entry_t{
 
 struct json_value_t {
     enum json_type_t type;
+    uint64_t hash; // Structural hash, 0 until json_hash() has visited the node
     union {
         int boolean;
         double number;
@@ -109,7 +117,7 @@ static bool scan_string(const char** cursor, const char* end, size_t* out_len) {
             (*cursor)++;
             if (*cursor >= end) return false;
             // Handle escape (simplified count)
-            if (**cursor == 'u') *cursor += 4; // unicode
+            if (**cursor == 'u') { *cursor += 4; len += 4; } // unicode, copied as "uXXXX" by parse_string_text
             len++;
         } else {
             len++;
@@ -548,6 +556,1094 @@ struct json_value_t *parse_json(const char* input, size_t length, char* error_bu
     return root;
 }
 
+/*
+Compressed input: a decompressor thread inflates the file in fixed-size blocks and hands them to the parsing thread through
+a bounded ring. The parsing thread builds the tree from each block as it arrives and releases the block right away, so
+decompression and parsing overlap and neither the compressed nor the decompressed document is ever held in memory as a whole.
+Besides the arena, the only other memory is the ring and the finished children of containers that are still open.
+*/
+#define JSON_BLOCK_SIZE  (64 * 1024)
+#define JSON_RING_BLOCKS 4
+
+enum json_codec_t{
+    JSON_CODEC_AUTO,    // Sniff gzip/zstd magic, otherwise plain text
+    JSON_CODEC_NONE,
+    JSON_CODEC_GZIP,    // needs JSON_WITH_ZLIB
+    JSON_CODEC_ZSTD     // needs JSON_WITH_ZSTD
+};
+
+struct json_block_t{
+    char data[JSON_BLOCK_SIZE];
+    size_t len;
+};
+
+// Single producer / single consumer ring of blocks
+struct json_ring_t{
+    struct json_block_t blocks[JSON_RING_BLOCKS];
+    size_t head;            // Next slot the producer fills
+    size_t tail;            // Next slot the consumer reads
+    size_t used;            // Published, not yet released
+    bool eof;               // Producer is done (see err_msg)
+    bool aborted;           // Consumer gave up, producer should stop
+    const char* err_msg;
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+};
+
+struct json_pipe_t{
+    struct json_ring_t ring;
+    FILE* fp;
+    enum json_codec_t codec;
+    unsigned char in[JSON_BLOCK_SIZE]; // Compressed input buffer (producer only)
+};
+
+// Producer: wait for a free slot. Returns NULL if the consumer aborted.
+static struct json_block_t *ring_acquire(struct json_ring_t *ring) {
+    pthread_mutex_lock(&ring->lock);
+    while (ring->used == JSON_RING_BLOCKS && !ring->aborted)
+        pthread_cond_wait(&ring->not_full, &ring->lock);
+    struct json_block_t *blk = ring->aborted ? NULL : &ring->blocks[ring->head];
+    pthread_mutex_unlock(&ring->lock);
+    if (blk) blk->len = 0;
+    return blk;
+}
+
+static void ring_publish(struct json_ring_t *ring) {
+    pthread_mutex_lock(&ring->lock);
+    ring->head = (ring->head + 1) % JSON_RING_BLOCKS;
+    ring->used++;
+    pthread_cond_signal(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static void ring_finish(struct json_ring_t *ring, const char* err_msg) {
+    pthread_mutex_lock(&ring->lock);
+    ring->eof = true;
+    ring->err_msg = err_msg;
+    pthread_cond_signal(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+// Consumer: wait for a published block. Returns NULL once the producer is done.
+static struct json_block_t *ring_take(struct json_ring_t *ring) {
+    pthread_mutex_lock(&ring->lock);
+    while (ring->used == 0 && !ring->eof)
+        pthread_cond_wait(&ring->not_empty, &ring->lock);
+    struct json_block_t *blk = ring->used ? &ring->blocks[ring->tail] : NULL;
+    pthread_mutex_unlock(&ring->lock);
+    return blk;
+}
+
+static void ring_release(struct json_ring_t *ring) {
+    pthread_mutex_lock(&ring->lock);
+    ring->tail = (ring->tail + 1) % JSON_RING_BLOCKS;
+    ring->used--;
+    pthread_cond_signal(&ring->not_full);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static void ring_abort(struct json_ring_t *ring) {
+    pthread_mutex_lock(&ring->lock);
+    ring->aborted = true;
+    pthread_cond_signal(&ring->not_full);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+// Publish the current block once full and grab the next one
+static bool pipe_flush_full(struct json_pipe_t *pipe, struct json_block_t **blk) {
+    if ((*blk)->len < JSON_BLOCK_SIZE)
+        return true;
+    ring_publish(&pipe->ring);
+    *blk = ring_acquire(&pipe->ring);
+    return *blk != NULL;
+}
+
+static const char *decode_plain(struct json_pipe_t *pipe, size_t in_len) {
+    struct json_block_t *blk = ring_acquire(&pipe->ring);
+    if (!blk) return NULL;
+
+    memcpy(blk->data, pipe->in, in_len);
+    blk->len = in_len;
+    while (true) {
+        if (!pipe_flush_full(pipe, &blk)) return NULL;
+        size_t n = fread(blk->data + blk->len, 1, JSON_BLOCK_SIZE - blk->len, pipe->fp);
+        if (n == 0) break;
+        blk->len += n;
+    }
+    if (ferror(pipe->fp)) return "Read error";
+    if (blk->len) ring_publish(&pipe->ring);
+    return NULL;
+}
+
+#ifdef JSON_WITH_ZLIB
+static const char *decode_gzip(struct json_pipe_t *pipe, size_t in_len) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, 15 + 32) != Z_OK) // +32: accept gzip and zlib headers
+        return "zlib init failed";
+
+    const char* err = NULL;
+    bool stream_end = false;
+    bool out_full = false;
+    struct json_block_t *blk = ring_acquire(&pipe->ring);
+    zs.next_in = pipe->in;
+    zs.avail_in = (uInt)in_len;
+
+    while (blk) {
+        // Refill input only when inflate is not still draining buffered output.
+        // Z_STREAM_END means everything was flushed, so a full block does not matter then.
+        if (zs.avail_in == 0 && (stream_end || !out_full)) {
+            size_t n = fread(pipe->in, 1, JSON_BLOCK_SIZE, pipe->fp);
+            if (n == 0) {
+                if (ferror(pipe->fp)) err = "Read error";
+                else if (!stream_end) err = "Truncated gzip stream";
+                break;
+            }
+            zs.next_in = pipe->in;
+            zs.avail_in = (uInt)n;
+        }
+        if (stream_end) { // More input after a member: concatenated gzip members
+            inflateReset(&zs);
+            stream_end = false;
+        }
+
+        zs.next_out = (Bytef *)blk->data + blk->len;
+        zs.avail_out = (uInt)(JSON_BLOCK_SIZE - blk->len);
+        int rc = inflate(&zs, Z_NO_FLUSH);
+        blk->len = JSON_BLOCK_SIZE - zs.avail_out;
+        out_full = zs.avail_out == 0;
+
+        if (rc == Z_STREAM_END) {
+            stream_end = true;
+        } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            err = "Corrupt gzip stream";
+            break;
+        }
+        if (!pipe_flush_full(pipe, &blk)) break;
+    }
+
+    if (blk && !err && blk->len) ring_publish(&pipe->ring);
+    inflateEnd(&zs);
+    return err;
+}
+#endif
+
+#ifdef JSON_WITH_ZSTD
+static const char *decode_zstd(struct json_pipe_t *pipe, size_t in_len) {
+    ZSTD_DStream *zs = ZSTD_createDStream();
+    if (!zs) return "zstd init failed";
+    ZSTD_initDStream(zs);
+
+    const char* err = NULL;
+    bool frame_done = false; // Last frame fully decoded and flushed, no new one started
+    bool out_full = false;
+    struct json_block_t *blk = ring_acquire(&pipe->ring);
+    ZSTD_inBuffer ib = { pipe->in, in_len, 0 };
+
+    while (blk) {
+        if (ib.pos == ib.size && (frame_done || !out_full)) {
+            size_t n = fread(pipe->in, 1, JSON_BLOCK_SIZE, pipe->fp);
+            if (n == 0) {
+                if (ferror(pipe->fp)) err = "Read error";
+                else if (!frame_done) err = "Truncated zstd stream";
+                break;
+            }
+            ib.size = n;
+            ib.pos = 0;
+        }
+
+        ZSTD_outBuffer ob = { blk->data, JSON_BLOCK_SIZE, blk->len };
+        size_t hint = ZSTD_decompressStream(zs, &ob, &ib);
+        if (ZSTD_isError(hint)) {
+            err = "Corrupt zstd stream";
+            break;
+        }
+        frame_done = hint == 0;
+        blk->len = ob.pos;
+        out_full = ob.pos == ob.size;
+        if (!pipe_flush_full(pipe, &blk)) break;
+    }
+
+    if (blk && !err && blk->len) ring_publish(&pipe->ring);
+    ZSTD_freeDStream(zs);
+    return err;
+}
+#endif
+
+static void *decompress_thread(void *arg) {
+    struct json_pipe_t *pipe = arg;
+    size_t n = fread(pipe->in, 1, JSON_BLOCK_SIZE, pipe->fp);
+    enum json_codec_t codec = pipe->codec;
+
+    if (codec == JSON_CODEC_AUTO) {
+        if (n >= 2 && pipe->in[0] == 0x1f && pipe->in[1] == 0x8b)
+            codec = JSON_CODEC_GZIP;
+        else if (n >= 4 && pipe->in[0] == 0x28 && pipe->in[1] == 0xb5 && pipe->in[2] == 0x2f && pipe->in[3] == 0xfd)
+            codec = JSON_CODEC_ZSTD;
+        else
+            codec = JSON_CODEC_NONE;
+    }
+
+    const char* err;
+    switch (codec) {
+#ifdef JSON_WITH_ZLIB
+        case JSON_CODEC_GZIP: err = decode_gzip(pipe, n); break;
+#endif
+#ifdef JSON_WITH_ZSTD
+        case JSON_CODEC_ZSTD: err = decode_zstd(pipe, n); break;
+#endif
+        case JSON_CODEC_NONE: err = decode_plain(pipe, n); break;
+        default:              err = "Codec not compiled in"; break;
+    }
+
+    ring_finish(&pipe->ring, err);
+    return NULL;
+}
+
+// Incremental parser for the block stream. It accepts the same grammar as pass1_analyze and builds the same
+// tree as fill_node, but it is driven one byte at a time, so each block can be dropped as soon as it has been fed.
+// The children of an open container wait on a scratch stack. When the container closes they are copied into
+// one contiguous run in the arena. That keeps the layout fill_node produces without a counting pass over the text.
+enum scan_state_t{
+    SCAN_VALUE,          // Expecting a value
+    SCAN_ARRAY_FIRST,    // After '[': value or ']'
+    SCAN_OBJECT_FIRST,   // After '{': key or '}'
+    SCAN_KEY,            // After ',' inside an object
+    SCAN_COLON,
+    SCAN_AFTER_VALUE,    // ',' or the closing bracket of the current container
+    SCAN_STRING,
+    SCAN_STRING_ESC,
+    SCAN_NUMBER,
+    SCAN_LITERAL,
+    SCAN_COMMENT,
+    SCAN_DONE,
+    SCAN_ERROR
+};
+
+struct stream_frame_t{
+    char open;                  // '{' or '['
+    size_t first;               // Index of its first child in `children`
+    size_t key;                 // Its own key, when its parent is an object
+    size_t key_len;
+};
+
+struct stream_child_t{
+    struct json_value_t value;
+    size_t key;                 // Arena offset of the key (object members only)
+    size_t key_len;
+};
+
+struct stream_scan_t{
+    enum scan_state_t state;
+    enum scan_state_t resume;   // State to return to after a comment
+    int comment;                // 0: saw '/', 1: line comment, 2: block comment, 3: block comment saw '*'
+    bool in_key;
+    const char* literal;
+    size_t lit_pos;
+
+    struct stream_frame_t *stack;   // Open containers
+    size_t depth;
+    size_t stack_cap;
+
+    struct stream_child_t *children; // Finished children of the open containers
+    size_t child_count;
+    size_t child_cap;
+    size_t key;                 // Pending object key
+    size_t key_len;
+
+    // Growable arena. Slot 0 is the root. Inside it everything refers to everything else by offset
+    // (stored in the pointer fields) until stream_finish() turns the offsets into pointers.
+    char* arena;
+    size_t arena_len;
+    size_t arena_cap;
+    size_t str_start;           // Offset of the string being decoded
+
+    char* token;                // Number text, which may span blocks
+    size_t token_len;
+    size_t token_cap;
+
+    const char* err_msg;
+};
+
+#define ARENA_OFF(p) ((size_t)(uintptr_t)(p))
+#define ARENA_REF(off) ((void *)(uintptr_t)(off))
+
+static void stream_fail(struct stream_scan_t *s, const char* msg) {
+    s->state = SCAN_ERROR;
+    s->err_msg = msg;
+}
+
+static bool grow(void **buf, size_t *cap, size_t need, size_t elem, size_t initial) {
+    if (need <= *cap)
+        return true;
+    size_t n = *cap ? *cap : initial;
+    while (n < need) n *= 2;
+    void* grown = realloc(*buf, n * elem);
+    if (!grown)
+        return false;
+    *buf = grown;
+    *cap = n;
+    return true;
+}
+
+// Reserve `size` aligned bytes and return their offset, 0 on failure (0 is the root slot, never handed out)
+static size_t stream_alloc(struct stream_scan_t *s, size_t size) {
+    size_t align = _Alignof(struct json_value_t);
+    size_t off = (s->arena_len + align - 1) & ~(align - 1);
+    if (!grow((void **)&s->arena, &s->arena_cap, off + size, 1, JSON_BLOCK_SIZE)) {
+        stream_fail(s, "Memory allocation failed");
+        return 0;
+    }
+    memset(s->arena + off, 0, size);
+    s->arena_len = off + size;
+    return off;
+}
+
+static void stream_append(struct stream_scan_t *s, const char* data, size_t n) {
+    if (!grow((void **)&s->arena, &s->arena_cap, s->arena_len + n, 1, JSON_BLOCK_SIZE)) {
+        stream_fail(s, "Memory allocation failed");
+        return;
+    }
+    memcpy(s->arena + s->arena_len, data, n);
+    s->arena_len += n;
+}
+
+static void stream_init(struct stream_scan_t *s) {
+    memset(s, 0, sizeof(*s));
+    s->state = SCAN_VALUE;
+    stream_alloc(s, sizeof(struct json_value_t)); // Root slot at offset 0
+}
+
+static void stream_free(struct stream_scan_t *s) {
+    free(s->stack);
+    free(s->children);
+    free(s->token);
+    free(s->arena);
+}
+
+// A value is complete: it becomes the root, or the next child of the innermost container
+static void stream_emit(struct stream_scan_t *s, const struct json_value_t *value) {
+    if (s->depth == 0) {
+        memcpy(s->arena, value, sizeof(*value));
+        s->state = SCAN_DONE;
+        return;
+    }
+    if (!grow((void **)&s->children, &s->child_cap, s->child_count + 1, sizeof(*s->children), 64)) {
+        stream_fail(s, "Memory allocation failed");
+        return;
+    }
+    struct stream_child_t *child = &s->children[s->child_count++];
+    child->value = *value;
+    child->key = s->key;
+    child->key_len = s->key_len;
+    s->state = SCAN_AFTER_VALUE;
+}
+
+// Reserve contiguous memory for the closing container's children and move them there
+static void stream_close(struct stream_scan_t *s) {
+    struct stream_frame_t frame = s->stack[--s->depth];
+    size_t count = s->child_count - frame.first;
+    struct stream_child_t *kids = s->children + frame.first;
+    struct json_value_t node = {0};
+
+    if (frame.open == '[') {
+        node.type = JSON_ARRAY;
+        node.data.array.count = count;
+        if (count) {
+            size_t items = stream_alloc(s, count * sizeof(struct json_value_t));
+            if (!items) return;
+            struct json_value_t *dst = (struct json_value_t *)(s->arena + items);
+            for (size_t i = 0; i < count; i++) dst[i] = kids[i].value;
+            node.data.array.items = ARENA_REF(items);
+        }
+    } else {
+        node.type = JSON_OBJECT;
+        node.data.object.count = count;
+        if (count) {
+            size_t entries = stream_alloc(s, count * sizeof(struct json_entry_t));
+            size_t values = entries ? stream_alloc(s, count * sizeof(struct json_value_t)) : 0;
+            if (!values) return;
+            struct json_entry_t *e = (struct json_entry_t *)(s->arena + entries);
+            struct json_value_t *v = (struct json_value_t *)(s->arena + values);
+            for (size_t i = 0; i < count; i++) {
+                v[i] = kids[i].value;
+                e[i].key = ARENA_REF(kids[i].key);
+                e[i].key_len = kids[i].key_len;
+                e[i].value = ARENA_REF(values + i * sizeof(struct json_value_t));
+            }
+            node.data.object.entries = ARENA_REF(entries);
+        }
+    }
+
+    s->child_count = frame.first;
+    s->key = frame.key; // Keys inside the container replaced the pending one
+    s->key_len = frame.key_len;
+    stream_emit(s, &node);
+}
+
+static void stream_number_done(struct stream_scan_t *s) {
+    struct json_value_t node = {0};
+    node.type = JSON_NUMBER;
+    s->token[s->token_len] = '\0';
+    node.data.number = strtod(s->token, NULL);
+    stream_emit(s, &node);
+}
+
+static void stream_begin_value(struct stream_scan_t *s, char c) {
+    if (c == '{' || c == '[') {
+        if (!grow((void **)&s->stack, &s->stack_cap, s->depth + 1, sizeof(*s->stack), 64)) {
+            stream_fail(s, "Memory allocation failed");
+            return;
+        }
+        s->stack[s->depth].open = c;
+        s->stack[s->depth].first = s->child_count;
+        s->stack[s->depth].key = s->key;
+        s->stack[s->depth].key_len = s->key_len;
+        s->depth++;
+        s->state = (c == '{') ? SCAN_OBJECT_FIRST : SCAN_ARRAY_FIRST;
+    } else if (c == '"') {
+        s->in_key = false;
+        s->str_start = s->arena_len;
+        s->state = SCAN_STRING;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        s->token_len = 0;
+        s->state = SCAN_NUMBER;
+        if (grow((void **)&s->token, &s->token_cap, 2, 1, 64)) s->token[s->token_len++] = c;
+        else stream_fail(s, "Memory allocation failed");
+    } else if (c == 't' || c == 'f' || c == 'n') {
+        s->literal = (c == 't') ? "true" : (c == 'f') ? "false" : "null";
+        s->lit_pos = 1;
+        s->state = SCAN_LITERAL;
+    } else {
+        stream_fail(s, NULL);
+    }
+}
+
+static bool is_number_char(char c) {
+    return isdigit(c) || c == '.' || c == '-' || c == 'e' || c == 'E' || c == '+';
+}
+
+static bool stream_feed(struct stream_scan_t *s, const char* buf, size_t len) {
+    size_t i = 0;
+    while (i < len && s->state != SCAN_ERROR && s->state != SCAN_DONE) {
+        char c = buf[i];
+
+        switch (s->state) {
+            case SCAN_VALUE:
+            case SCAN_ARRAY_FIRST:
+            case SCAN_OBJECT_FIRST:
+            case SCAN_KEY:
+            case SCAN_COLON:
+            case SCAN_AFTER_VALUE:
+                if (isspace(c)) break;
+                if (c == '/') {
+                    s->resume = s->state;
+                    s->comment = 0;
+                    s->state = SCAN_COMMENT;
+                    break;
+                }
+
+                if (s->state == SCAN_VALUE) {
+                    stream_begin_value(s, c);
+                } else if (s->state == SCAN_ARRAY_FIRST) {
+                    if (c == ']') stream_close(s);
+                    else stream_begin_value(s, c);
+                } else if (s->state == SCAN_COLON) {
+                    if (c == ':') s->state = SCAN_VALUE;
+                    else stream_fail(s, NULL);
+                } else if (s->state == SCAN_AFTER_VALUE) {
+                    char open = s->stack[s->depth - 1].open;
+                    if (c == ',') s->state = (open == '{') ? SCAN_KEY : SCAN_VALUE;
+                    else if ((open == '{' && c == '}') || (open == '[' && c == ']')) stream_close(s);
+                    else stream_fail(s, NULL);
+                } else { // Object key position
+                    if (c == '}' && s->state == SCAN_OBJECT_FIRST) {
+                        stream_close(s);
+                    } else if (c == '"') {
+                        s->in_key = true;
+                        s->str_start = s->arena_len;
+                        s->state = SCAN_STRING;
+                    } else {
+                        stream_fail(s, NULL);
+                    }
+                }
+                break;
+
+            case SCAN_STRING: {
+                // Copy the run up to the next quote or escape in one go
+                size_t run = i;
+                while (run < len && buf[run] != '"' && buf[run] != '\\') run++;
+                stream_append(s, buf + i, run - i);
+                i = run;
+                if (i == len || s->state == SCAN_ERROR) continue;
+
+                if (buf[i] == '\\') {
+                    s->state = SCAN_STRING_ESC;
+                    break;
+                }
+                stream_append(s, "", 1); // null terminator
+                size_t str_len = s->arena_len - s->str_start - 1;
+                if (s->in_key) {
+                    s->key = s->str_start;
+                    s->key_len = str_len;
+                    s->state = SCAN_COLON;
+                } else if (s->state != SCAN_ERROR) {
+                    struct json_value_t node = {0};
+                    node.type = JSON_STRING;
+                    node.data.string.val = ARENA_REF(s->str_start);
+                    node.data.string.len = str_len;
+                    stream_emit(s, &node);
+                }
+                break;
+            }
+
+            case SCAN_STRING_ESC:
+                // Same simplified escapes as parse_string_text; \uXXXX is kept as "uXXXX"
+                c = (c == 'n') ? '\n' : (c == 't') ? '\t' : c;
+                stream_append(s, &c, 1);
+                if (s->state != SCAN_ERROR) s->state = SCAN_STRING;
+                break;
+
+            case SCAN_NUMBER: {
+                size_t run = i;
+                while (run < len && is_number_char(buf[run])) run++;
+                if (!grow((void **)&s->token, &s->token_cap, s->token_len + (run - i) + 1, 1, 64)) {
+                    stream_fail(s, "Memory allocation failed");
+                    continue;
+                }
+                memcpy(s->token + s->token_len, buf + i, run - i);
+                s->token_len += run - i;
+                i = run;
+                if (i < len) stream_number_done(s); // Re-dispatch the terminator in the new state
+                continue;
+            }
+
+            case SCAN_LITERAL:
+                if (c != s->literal[s->lit_pos]) { stream_fail(s, NULL); break; }
+                if (s->literal[++s->lit_pos] == '\0') {
+                    struct json_value_t node = {0};
+                    node.type = (s->literal[0] == 'n') ? JSON_NULL : JSON_BOOL;
+                    node.data.boolean = s->literal[0] == 't';
+                    stream_emit(s, &node);
+                }
+                break;
+
+            case SCAN_COMMENT:
+                if (s->comment == 0) {
+                    if (c == '/') s->comment = 1;
+                    else if (c == '*') s->comment = 2;
+                    else stream_fail(s, NULL); // Not a comment
+                } else if (s->comment == 1) {
+                    if (c == '\n') s->state = s->resume;
+                } else if (s->comment == 2) {
+                    if (c == '*') s->comment = 3;
+                } else {
+                    if (c == '/') s->state = s->resume;
+                    else if (c != '*') s->comment = 2;
+                }
+                break;
+
+            default:
+                break;
+        }
+        i++;
+    }
+    return s->state != SCAN_ERROR;
+}
+
+// Offsets were stored in the pointer fields while the arena could still move
+static void stream_relocate(struct json_value_t *node, char* base) {
+    switch (node->type) {
+        case JSON_STRING:
+            node->data.string.val = base + ARENA_OFF(node->data.string.val);
+            break;
+        case JSON_ARRAY:
+            if (node->data.array.count == 0) break;
+            node->data.array.items = (struct json_value_t *)(base + ARENA_OFF(node->data.array.items));
+            for (size_t i = 0; i < node->data.array.count; i++)
+                stream_relocate(&node->data.array.items[i], base);
+            break;
+        case JSON_OBJECT:
+            if (node->data.object.count == 0) break;
+            node->data.object.entries = (struct json_entry_t *)(base + ARENA_OFF(node->data.object.entries));
+            for (size_t i = 0; i < node->data.object.count; i++) {
+                struct json_entry_t *e = &node->data.object.entries[i];
+                e->key = base + ARENA_OFF(e->key);
+                e->value = (struct json_value_t *)(base + ARENA_OFF(e->value));
+                stream_relocate(e->value, base);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// End of input. Returns the root (the arena now belongs to the caller), or NULL if the document is incomplete.
+static struct json_value_t *stream_finish(struct stream_scan_t *s) {
+    // A top-level number has no terminator, it simply runs to EOF
+    if (s->state == SCAN_NUMBER && s->depth == 0)
+        stream_number_done(s);
+    if (s->state != SCAN_DONE)
+        return NULL;
+
+    char* shrunk = realloc(s->arena, s->arena_len); // Trim the growth slack before handing it out
+    if (shrunk) s->arena = shrunk;
+
+    struct json_value_t *root = (struct json_value_t *)s->arena;
+    stream_relocate(root, s->arena);
+    s->arena = NULL;
+    return root;
+}
+
+struct json_value_t *parse_json_compressed(FILE* fp, enum json_codec_t codec, char* error_buffer) {
+    struct json_pipe_t *pipe = calloc(1, sizeof(*pipe));
+    if (!pipe) {
+        if (error_buffer) sprintf(error_buffer, "Memory allocation failed");
+        return NULL;
+    }
+    pipe->fp = fp;
+    pipe->codec = codec;
+    pthread_mutex_init(&pipe->ring.lock, NULL);
+    pthread_cond_init(&pipe->ring.not_empty, NULL);
+    pthread_cond_init(&pipe->ring.not_full, NULL);
+
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, decompress_thread, pipe) != 0) {
+        if (error_buffer) sprintf(error_buffer, "Failed to start decompressor thread");
+        free(pipe);
+        return NULL;
+    }
+
+    struct stream_scan_t scan;
+    stream_init(&scan);
+    const char* err = scan.err_msg;
+
+    // --- Parse each block while the next ones are being decompressed ---
+    struct json_block_t *blk;
+    while (!err && (blk = ring_take(&pipe->ring)) != NULL) {
+        if (!stream_feed(&scan, blk->data, blk->len))
+            err = scan.err_msg ? scan.err_msg : "Syntax Error or Unexpected EOF";
+        ring_release(&pipe->ring);
+    }
+
+    if (err) ring_abort(&pipe->ring);
+    pthread_join(producer, NULL);
+    if (!err) err = pipe->ring.err_msg;
+
+    struct json_value_t *root = err ? NULL : stream_finish(&scan);
+    if (!root && !err) err = scan.err_msg ? scan.err_msg : "Syntax Error or Unexpected EOF";
+    if (err && error_buffer) sprintf(error_buffer, "%s", err);
+
+    pthread_cond_destroy(&pipe->ring.not_full);
+    pthread_cond_destroy(&pipe->ring.not_empty);
+    pthread_mutex_destroy(&pipe->ring.lock);
+    free(pipe);
+    stream_free(&scan);
+    return root;
+}
+
+/*
+Structural hashing: an optional pass over a parsed tree that stores a 64-bit hash in every node (the
+`hash` field lives inside the node, so it sits in the same arena slot). Arrays mix their children in order,
+objects combine their entries with a commutative sum so key order does not matter. json_equal() and json_diff()
+skip a branch whose hashes match and reject one whose hashes differ, without walking it. A 64-bit collision would
+make two different branches look equal; json_equal_exact() confirms matches for callers that cannot accept that.
+*/
+#define JSON_HASH_SEED 0x9e3779b97f4a7c15ULL
+
+static uint64_t hash_mix(uint64_t h) {
+    // splitmix64 finalizer
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+static uint64_t hash_bytes(const char *data, size_t len, uint64_t seed) {
+    // FNV-1a over the bytes, then mixed so short strings spread over all 64 bits
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return hash_mix(h ^ len);
+}
+
+uint64_t json_hash(struct json_value_t *val) {
+    if (!val)
+        return 0;
+
+    uint64_t h = hash_mix(JSON_HASH_SEED + (uint64_t)val->type);
+
+    switch (val->type) {
+        case JSON_NULL:
+            break;
+        case JSON_BOOL:
+            h = hash_mix(h ^ (uint64_t)(val->data.boolean != 0));
+            break;
+        case JSON_NUMBER: {
+            double d = val->data.number;
+            if (d == 0.0) d = 0.0; // -0.0 and 0.0 compare equal, so they must hash equal
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            h = hash_mix(h ^ bits);
+            break;
+        }
+        case JSON_STRING:
+            h = hash_bytes(val->data.string.val, val->data.string.len, h);
+            break;
+        case JSON_ARRAY:
+            // Order-dependent: each child is folded into the running state
+            for (size_t i = 0; i < val->data.array.count; i++) {
+                h = hash_mix(h + json_hash(&val->data.array.items[i]));
+            }
+            h = hash_mix(h ^ val->data.array.count);
+            break;
+        case JSON_OBJECT: {
+            // Order-independent: sum of per-entry hashes (key bound to its value)
+            uint64_t sum = 0;
+            for (size_t i = 0; i < val->data.object.count; i++) {
+                struct json_entry_t *e = &val->data.object.entries[i];
+                uint64_t kh = hash_bytes(e->key, e->key_len, JSON_HASH_SEED);
+                sum += hash_mix(kh ^ json_hash(e->value));
+            }
+            h = hash_mix(h ^ sum ^ val->data.object.count);
+            break;
+        }
+    }
+
+    if (h == 0) h = 1; // 0 is reserved for "not hashed"
+    val->hash = h;
+    return h;
+}
+
+static int key_cmp(const struct json_entry_t *a, const struct json_entry_t *b) {
+    size_t n = a->key_len < b->key_len ? a->key_len : b->key_len;
+    int c = memcmp(a->key, b->key, n);
+    if (c)
+        return c;
+    return (a->key_len > b->key_len) - (a->key_len < b->key_len);
+}
+
+// Orders entries by key. Ties keep document order, so duplicate keys pair up positionally.
+static int entry_sort_cmp(const void *pa, const void *pb) {
+    const struct json_entry_t *a = *(const struct json_entry_t *const *)pa;
+    const struct json_entry_t *b = *(const struct json_entry_t *const *)pb;
+    int c = key_cmp(a, b);
+    return c ? c : (a > b) - (a < b);
+}
+
+#define JSON_INDEX_LOCAL 16 // Objects up to this size are indexed on the stack
+
+// Key-sorted view of an object's entries, in `local` when it fits. NULL if the heap allocation fails.
+static const struct json_entry_t **object_index(const struct json_value_t *obj, const struct json_entry_t **local) {
+    size_t n = obj->data.object.count;
+    const struct json_entry_t **idx = local;
+    if (n > JSON_INDEX_LOCAL) {
+        idx = malloc(n * sizeof(*idx));
+        if (!idx)
+            return NULL;
+    }
+    for (size_t i = 0; i < n; i++)
+        idx[i] = &obj->data.object.entries[i];
+    qsort(idx, n, sizeof(*idx), entry_sort_cmp);
+    return idx;
+}
+
+static void object_index_free(const struct json_entry_t **idx, const struct json_entry_t **local) {
+    if (idx != local)
+        free(idx);
+}
+
+static bool value_equal(const struct json_value_t *a, const struct json_value_t *b, bool exact);
+
+// Multiset compare without an index, only used when the index cannot be allocated
+static bool object_equal_slow(const struct json_value_t *a, const struct json_value_t *b, bool exact) {
+    size_t n = a->data.object.count;
+    for (size_t i = 0; i < n; i++) {
+        const struct json_entry_t *e = &a->data.object.entries[i];
+        size_t in_a = 0, in_b = 0;
+        for (size_t j = 0; j < n; j++) {
+            const struct json_entry_t *x = &a->data.object.entries[j];
+            const struct json_entry_t *y = &b->data.object.entries[j];
+            if (key_cmp(e, x) == 0 && value_equal(e->value, x->value, exact)) in_a++;
+            if (key_cmp(e, y) == 0 && value_equal(e->value, y->value, exact)) in_b++;
+        }
+        if (in_a != in_b)
+            return false;
+    }
+    return true;
+}
+
+// Shallow check, only needed when a positional compare failed. Allocation failure counts as "maybe".
+static bool has_duplicate_keys(const struct json_value_t *obj) {
+    const struct json_entry_t *local[JSON_INDEX_LOCAL];
+    const struct json_entry_t **idx = object_index(obj, local);
+    if (!idx)
+        return true;
+    bool dup = false;
+    for (size_t i = 1; !dup && i < obj->data.object.count; i++)
+        dup = key_cmp(idx[i - 1], idx[i]) == 0;
+    object_index_free(idx, local);
+    return dup;
+}
+
+// Objects are equal when their entries pair up one-to-one with equal keys and values
+static bool object_equal(const struct json_value_t *a, const struct json_value_t *b, bool exact) {
+    size_t n = a->data.object.count;
+    const struct json_entry_t *ea = a->data.object.entries, *eb = b->data.object.entries;
+
+    // Fast path: the same keys in the same order, as in two snapshots of one document.
+    // Pairing entries by position is then a valid pairing, so no index is needed.
+    size_t same = 0;
+    while (same < n && key_cmp(&ea[same], &eb[same]) == 0) same++;
+    if (same == n) {
+        size_t k = 0;
+        while (k < n && value_equal(ea[k].value, eb[k].value, exact)) k++;
+        if (k == n)
+            return true;
+        // A mismatch is final unless duplicate keys allow another pairing
+        if (!has_duplicate_keys(a))
+            return false;
+    }
+
+    // Keys in a different order (or duplicates): match through one key-sorted index per side
+    const struct json_entry_t *local_a[JSON_INDEX_LOCAL], *local_b[JSON_INDEX_LOCAL];
+    const struct json_entry_t **ia = object_index(a, local_a);
+    const struct json_entry_t **ib = object_index(b, local_b);
+
+    bool eq = true;
+    if (!ia || !ib) {
+        eq = object_equal_slow(a, b, exact);
+    } else {
+        for (size_t i = 0; eq && i < n; ) {
+            // Sorted key lists must match position by position
+            size_t run = i + 1;
+            while (run < n && key_cmp(ia[run], ia[i]) == 0) run++;
+            for (size_t k = i; k < run; k++) {
+                if (key_cmp(ia[k], ib[k]) != 0) { eq = false; break; }
+            }
+            if (eq && run < n && key_cmp(ib[run], ib[i]) == 0)
+                eq = false;
+
+            // Within a run of duplicate keys, pair each value of `a` with an unused equal value of `b`
+            for (size_t k = i; eq && k < run; k++) {
+                size_t m = k;
+                while (m < run && !value_equal(ia[k]->value, ib[m]->value, exact)) m++;
+                if (m == run) { eq = false; break; }
+                const struct json_entry_t *tmp = ib[k]; ib[k] = ib[m]; ib[m] = tmp;
+            }
+            i = run;
+        }
+    }
+
+    if (ia) object_index_free(ia, local_a);
+    if (ib) object_index_free(ib, local_b);
+    return eq;
+}
+
+static bool value_equal(const struct json_value_t *a, const struct json_value_t *b, bool exact) {
+    if (a == b)
+        return true;
+    if (!a || !b || a->type != b->type)
+        return false;
+    if (a->hash && b->hash) {
+        if (a->hash != b->hash)
+            return false;
+        if (!exact && (a->type == JSON_ARRAY || a->type == JSON_OBJECT))
+            return true;
+    }
+
+    switch (a->type) {
+        case JSON_NULL:
+            return true;
+        case JSON_BOOL:
+            return (a->data.boolean != 0) == (b->data.boolean != 0);
+        case JSON_NUMBER:
+            return a->data.number == b->data.number;
+        case JSON_STRING:
+            return a->data.string.len == b->data.string.len &&
+                   memcmp(a->data.string.val, b->data.string.val, a->data.string.len) == 0;
+        case JSON_ARRAY:
+            if (a->data.array.count != b->data.array.count)
+                return false;
+            for (size_t i = 0; i < a->data.array.count; i++) {
+                if (!value_equal(&a->data.array.items[i], &b->data.array.items[i], exact))
+                    return false;
+            }
+            return true;
+        case JSON_OBJECT:
+            if (a->data.object.count != b->data.object.count)
+                return false;
+            return object_equal(a, b, exact);
+    }
+    return false;
+}
+
+// Deep equality. On trees hashed with json_hash(), containers with equal hashes are taken as equal
+// without being walked: two different subtrees share a 64-bit hash with probability about 2^-64,
+// and json_equal() would then report them equal. Unhashed trees are always compared in full.
+bool json_equal(const struct json_value_t *a, const struct json_value_t *b) {
+    return value_equal(a, b, false);
+}
+
+// Like json_equal(), but equal hashes are confirmed by a full compare, so the answer is exact
+bool json_equal_exact(const struct json_value_t *a, const struct json_value_t *b) {
+    return value_equal(a, b, true);
+}
+
+// Called once per difference. `a` is NULL for an added value, `b` is NULL for a removed one.
+typedef void (*json_diff_cb)(const char *path, const struct json_value_t *a, const struct json_value_t *b, void *user);
+
+// Growable path buffer for json_diff
+struct diff_path_t{
+    char* buf;
+    size_t len;
+    size_t cap;
+};
+
+static bool path_append(struct diff_path_t *p, const char* s, size_t n) {
+    if (p->len + n + 1 > p->cap) {
+        size_t cap = p->cap ? p->cap : 64;
+        while (cap < p->len + n + 1) cap *= 2;
+        char* grown = realloc(p->buf, cap);
+        if (!grown)
+            return false;
+        p->buf = grown;
+        p->cap = cap;
+    }
+    memcpy(p->buf + p->len, s, n);
+    p->len += n;
+    p->buf[p->len] = '\0';
+    return true;
+}
+
+static bool path_index(struct diff_path_t *p, size_t i) {
+    char tmp[32];
+    int w = snprintf(tmp, sizeof(tmp), "[%zu]", i);
+    return path_append(p, tmp, (size_t)w);
+}
+
+// Identifier-like keys print as `.key`, anything else as `["key"]` with `"`, `\` and control bytes escaped
+static bool path_key(struct diff_path_t *p, const char* key, size_t len) {
+    bool plain = len > 0 && !isdigit((unsigned char)key[0]);
+    for (size_t i = 0; plain && i < len; i++) {
+        unsigned char c = (unsigned char)key[i];
+        plain = isalnum(c) || c == '_' || c == '$';
+    }
+    if (plain)
+        return path_append(p, ".", 1) && path_append(p, key, len);
+
+    if (!path_append(p, "[\"", 2))
+        return false;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)key[i];
+        char tmp[8];
+        bool ok;
+        if (c == '"' || c == '\\') {
+            tmp[0] = '\\'; tmp[1] = (char)c;
+            ok = path_append(p, tmp, 2);
+        } else if (c < 0x20) {
+            snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+            ok = path_append(p, tmp, 6);
+        } else {
+            ok = path_append(p, key + i, 1);
+        }
+        if (!ok)
+            return false;
+    }
+    return path_append(p, "\"]", 2);
+}
+
+static bool diff_walk(const struct json_value_t *a, const struct json_value_t *b,
+                      struct diff_path_t *path, json_diff_cb cb, void *user) {
+    if (a == b)
+        return true;
+    // Matching hashes prune the subtree without visiting it
+    if (a && b && a->hash && b->hash && a->hash == b->hash)
+        return true;
+
+    if (!a || !b || a->type != b->type ||
+        (a->type != JSON_ARRAY && a->type != JSON_OBJECT)) {
+        if (!json_equal(a, b))
+            cb(path->buf, a, b, user);
+        return true;
+    }
+
+    size_t mark = path->len;
+    bool ok = true;
+
+    if (a->type == JSON_ARRAY) {
+        size_t n = a->data.array.count > b->data.array.count ? a->data.array.count : b->data.array.count;
+        for (size_t i = 0; ok && i < n; i++) {
+            const struct json_value_t *ca = i < a->data.array.count ? &a->data.array.items[i] : NULL;
+            const struct json_value_t *cb_ = i < b->data.array.count ? &b->data.array.items[i] : NULL;
+            ok = path_index(path, i) && diff_walk(ca, cb_, path, cb, user);
+            path->len = mark;
+            path->buf[mark] = '\0';
+        }
+        return ok;
+    }
+
+    // Objects with the same keys in the same order pair up by position, no index needed
+    size_t na = a->data.object.count, nb = b->data.object.count;
+    size_t same = 0;
+    while (na == nb && same < na && key_cmp(&a->data.object.entries[same], &b->data.object.entries[same]) == 0) same++;
+    if (na == nb && same == na) {
+        for (size_t i = 0; ok && i < na; i++) {
+            const struct json_entry_t *e = &a->data.object.entries[i];
+            ok = path_key(path, e->key, e->key_len) &&
+                 diff_walk(e->value, b->data.object.entries[i].value, path, cb, user);
+            path->len = mark;
+            path->buf[mark] = '\0';
+        }
+        return ok;
+    }
+
+    // Otherwise merge the two key-sorted entry lists
+    const struct json_entry_t *local_a[JSON_INDEX_LOCAL], *local_b[JSON_INDEX_LOCAL];
+    const struct json_entry_t **ia = object_index(a, local_a);
+    const struct json_entry_t **ib = object_index(b, local_b);
+    ok = ia && ib;
+
+    for (size_t i = 0, j = 0; ok && (i < na || j < nb); ) {
+        int c = (i == na) ? 1 : (j == nb) ? -1 : key_cmp(ia[i], ib[j]);
+        const struct json_entry_t *e = (c <= 0) ? ia[i] : ib[j];
+        ok = path_key(path, e->key, e->key_len);
+        if (ok) {
+            if (c < 0)      cb(path->buf, ia[i]->value, NULL, user);
+            else if (c > 0) cb(path->buf, NULL, ib[j]->value, user);
+            else            ok = diff_walk(ia[i]->value, ib[j]->value, path, cb, user);
+        }
+        if (c <= 0) i++;
+        if (c >= 0) j++;
+        path->len = mark;
+        path->buf[mark] = '\0';
+    }
+
+    if (ia) object_index_free(ia, local_a);
+    if (ib) object_index_free(ib, local_b);
+    return ok;
+}
+
+// Reports every differing value between `a` and `b` with a path like `$.key[3]["odd.key"]`.
+// Object members are reported in document order when both objects list the same keys in the same order,
+// otherwise in key order. Hash both trees with json_hash() first so unchanged
+// subtrees are skipped unvisited (a hash collision would hide a change, see json_equal()).
+// Returns false if it ran out of memory, in which case the report is incomplete.
+bool json_diff(const struct json_value_t *a, const struct json_value_t *b, json_diff_cb cb, void *user) {
+    struct diff_path_t path = {0};
+    if (!cb)
+        return true;
+    if (!path_append(&path, "$", 1))
+        return false;
+    bool ok = diff_walk(a, b, &path, cb, user);
+    free(path.buf);
+    return ok;
+}
+
 void print_json(struct json_value_t* val, int indent) {
     if (!val) 
 		return;
@@ -597,8 +1693,20 @@ int main(int argc, char *argv[]) {
     // Calculate length of the embedded blob
     size_t len = json_end - json_start;
     char err_buf[256];
-    
-    struct json_value_t *root = parse_json((const char*)json_start , len, err_buf);
+    struct json_value_t *root;
+
+    if (argc > 1) {
+        // Parse a file instead, gzip/zstd input is detected and decompressed on the fly
+        FILE *fp = fopen(argv[1], "rb");
+        if (!fp) {
+            fprintf(stderr, "Cannot open %s\n", argv[1]);
+            return 1;
+        }
+        root = parse_json_compressed(fp, JSON_CODEC_AUTO, err_buf);
+        fclose(fp);
+    } else {
+        root = parse_json((const char*)json_start , len, err_buf);
+    }
 
     if (!root) {
         fprintf(stderr, "Parsing Failed: %s\n", err_buf);
@@ -608,6 +1716,8 @@ int main(int argc, char *argv[]) {
     printf("--- Parsed Tree ---\n");
     print_json(root, 0);
 
+    printf("\n--- Structural Hash: %016llx ---\n", (unsigned long long)json_hash(root));
+
     // Single free for the whole arena
     free(root);
     printf("\n--- Cleanup Done ---\n");
@@ -0,0 +1,414 @@
+// Behaviour checks for main.c. Build and run from the repository root:
+//   gcc -O1 -g tests/json_test.c -o json_test -lm -pthread && ./json_test
+// Add -DJSON_WITH_ZLIB ... -lz and/or -DJSON_WITH_ZSTD ... -lzstd to cover the compressed input cases.
+#define main json_demo_main
+#include "../main.c"
+#undef main
+
+unsigned char json_start[] = "null";
+unsigned char json_end[] = "";
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static struct json_value_t *parse(const char* text) {
+    char err[256];
+    struct json_value_t *root = parse_json(text, strlen(text), err);
+    if (!root) fprintf(stderr, "parse_json failed (%s): %s\n", err, text);
+    return root;
+}
+
+// --- Structural hashing, json_equal, json_diff ---
+
+// json_equal, checked in both directions, before and after hashing. All four must agree.
+static bool equal_any_way(const char* x, const char* y) {
+    struct json_value_t *a = parse(x), *b = parse(y);
+    bool ab = json_equal(a, b), ba = json_equal(b, a);
+    json_hash(a);
+    json_hash(b);
+    bool hab = json_equal(a, b), hba = json_equal(b, a);
+    CHECK(ab == ba && ab == hab && ab == hba);
+    if (ab) CHECK(a->hash == b->hash);
+    free(a);
+    free(b);
+    return ab;
+}
+
+struct diff_log_t{
+    char text[4096];
+    size_t len;
+};
+
+static void log_diff(const char* path, const struct json_value_t *a, const struct json_value_t *b, void* user) {
+    struct diff_log_t *log = user;
+    char kind = !a ? '+' : !b ? '-' : '~';
+    int w = snprintf(log->text + log->len, sizeof(log->text) - log->len, "%s %c\n", path, kind);
+    if (w > 0) log->len += (size_t)w;
+}
+
+// Runs json_diff unhashed and hashed and checks both reports match `expect`
+static void check_diff(const char* x, const char* y, const char* expect) {
+    struct json_value_t *a = parse(x), *b = parse(y);
+    for (int hashed = 0; hashed < 2; hashed++) {
+        if (hashed) { json_hash(a); json_hash(b); }
+        struct diff_log_t log = {{0}, 0};
+        CHECK(json_diff(a, b, log_diff, &log));
+        if (strcmp(log.text, expect) != 0) {
+            fprintf(stderr, "diff (%s) of\n  %s\n  %s\ngot:\n%sexpected:\n%s", hashed ? "hashed" : "unhashed", x, y, log.text, expect);
+            failures++;
+        }
+    }
+    free(a);
+    free(b);
+}
+
+static void test_equal(void) {
+    // Object key order is ignored, array order is not
+    CHECK(equal_any_way("{\"a\":1,\"b\":[1,2],\"c\":{\"d\":null}}", "{\"c\":{\"d\":null},\"b\":[1,2],\"a\":1}"));
+    CHECK(!equal_any_way("[1,2]", "[2,1]"));
+    CHECK(!equal_any_way("[1,2]", "[1,2,3]"));
+
+    // -0 and 0 compare (and hash) equal
+    CHECK(equal_any_way("-0", "0"));
+    CHECK(equal_any_way("[-0.0]", "[0]"));
+
+    CHECK(!equal_any_way("1", "\"1\""));
+    CHECK(!equal_any_way("null", "false"));
+    CHECK(!equal_any_way("{\"a\":1}", "{\"a\":1,\"b\":2}"));
+    CHECK(!equal_any_way("{\"a\":\"x\"}", "{\"b\":\"x\"}"));
+
+    // Duplicate keys: entries must pair up one-to-one
+    CHECK(!equal_any_way("{\"a\":1,\"a\":1}", "{\"a\":1,\"b\":1}"));
+    CHECK(!equal_any_way("{\"a\":1,\"b\":1}", "{\"a\":1,\"a\":1}"));
+    CHECK(equal_any_way("{\"a\":1,\"a\":2}", "{\"a\":2,\"a\":1}"));
+    CHECK(!equal_any_way("{\"a\":1,\"a\":1}", "{\"a\":1,\"a\":2}"));
+
+    // Objects big enough to be indexed on the heap
+    char x[1024], y[1024];
+    size_t xl = 0, yl = 0;
+    xl += (size_t)sprintf(x + xl, "{");
+    yl += (size_t)sprintf(y + yl, "{");
+    for (int i = 0; i < 40; i++) {
+        xl += (size_t)sprintf(x + xl, "%s\"k%d\":%d", i ? "," : "", i, i);
+        yl += (size_t)sprintf(y + yl, "%s\"k%d\":%d", i ? "," : "", 39 - i, 39 - i);
+    }
+    sprintf(x + xl, "}");
+    sprintf(y + yl, "}");
+    CHECK(equal_any_way(x, y));
+    y[yl - 1] = '7'; // "k0":0 -> "k0":7
+    CHECK(!equal_any_way(x, y));
+
+    // A hash match is trusted by json_equal and json_diff, and confirmed by json_equal_exact
+    struct json_value_t *a = parse("{\"a\":[1,2]}"), *b = parse("{\"a\":[1,3]}");
+    json_hash(a);
+    json_hash(b);
+    a->hash = b->hash = 42; // Forced collision
+    CHECK(json_equal(a, b));
+    CHECK(!json_equal_exact(a, b));
+    struct diff_log_t log = {{0}, 0};
+    CHECK(json_diff(a, b, log_diff, &log));
+    CHECK(log.len == 0);
+    free(a);
+    free(b);
+
+    // Exact compare agrees with the plain one when there is no collision
+    a = parse("{\"x\":[1,{\"y\":2}],\"z\":3}");
+    b = parse("{\"z\":3,\"x\":[1,{\"y\":2}]}");
+    CHECK(json_equal_exact(a, b));
+    json_hash(a);
+    json_hash(b);
+    CHECK(json_equal_exact(a, b));
+    b->data.object.entries[0].value->data.number = 4; // "z" changed behind the hashes' back
+    CHECK(json_equal(a, b));
+    CHECK(!json_equal_exact(a, b));
+    free(a);
+    free(b);
+}
+
+// Identical hashed subtrees are skipped without being visited: their contents are
+// poisoned after hashing, and neither json_equal nor json_diff may look inside
+static void test_hash_pruning(void) {
+    struct json_value_t *a = parse("{\"same\":{\"k\":[1,2,3],\"s\":\"v\"},\"changed\":1}");
+    struct json_value_t *b = parse("{\"same\":{\"k\":[1,2,3],\"s\":\"v\"},\"changed\":2}");
+    json_hash(a);
+    json_hash(b);
+
+    struct json_value_t *same_a = a->data.object.entries[0].value;
+    struct json_value_t *same_b = b->data.object.entries[0].value;
+    CHECK(same_a->hash == same_b->hash);
+    struct json_entry_t *saved_a = same_a->data.object.entries, *saved_b = same_b->data.object.entries;
+    same_a->data.object.entries = NULL; // Any visit would crash
+    same_b->data.object.entries = NULL;
+
+    CHECK(json_equal(same_a, same_b));
+    struct diff_log_t log = {{0}, 0};
+    CHECK(json_diff(a, b, log_diff, &log));
+    CHECK(strcmp(log.text, "$.changed ~\n") == 0);
+
+    same_a->data.object.entries = saved_a;
+    same_b->data.object.entries = saved_b;
+    free(a);
+    free(b);
+}
+
+static void test_diff(void) {
+    check_diff("{\"x\":{\"y\":[1,2,3]},\"gone\":true,\"same\":{\"k\":1}}",
+               "{\"same\":{\"k\":1},\"x\":{\"y\":[1,5]},\"new\":null}",
+               "$.gone -\n$.new +\n$.x.y[1] ~\n$.x.y[2] -\n");
+    check_diff("[1,{\"a\":1}]", "[1,{\"a\":1},[]]", "$[2] +\n");
+    check_diff("{\"a\":[1]}", "{\"a\":{\"0\":1}}", "$.a ~\n");
+    check_diff("{\"a\":1}", "{\"a\":1}", "");
+    check_diff("-0", "0", "");
+    check_diff("{\"a\":1,\"a\":2}", "{\"a\":1,\"a\":3}", "$.a ~\n");
+
+    // Keys that are not identifiers are quoted and escaped
+    check_diff("{\"a.b\":1,\"c[0]\":1,\"q\\\"\":1,\"\":1,\"0x\":1,\"_ok$\":1}",
+               "{\"a.b\":2,\"c[0]\":2,\"q\\\"\":2,\"\":2,\"0x\":2,\"_ok$\":2}",
+               "$[\"a.b\"] ~\n$[\"c[0]\"] ~\n$[\"q\\\"\"] ~\n$[\"\"] ~\n$[\"0x\"] ~\n$._ok$ ~\n");
+
+    // Paths longer than any fixed buffer are reported whole
+    enum { DEPTH = 120 };
+    static char x[DEPTH * 32], y[DEPTH * 32], expect[DEPTH * 32];
+    size_t xl = 0, el = 0;
+    el += (size_t)sprintf(expect, "$");
+    for (int i = 0; i < DEPTH; i++) {
+        xl += (size_t)sprintf(x + xl, "{\"level_%03d\":", i);
+        el += (size_t)sprintf(expect + el, ".level_%03d", i);
+    }
+    strcpy(y, x);
+    size_t yl = xl;
+    xl += (size_t)sprintf(x + xl, "1");
+    yl += (size_t)sprintf(y + yl, "2");
+    for (int i = 0; i < DEPTH; i++) {
+        x[xl++] = '}';
+        y[yl++] = '}';
+    }
+    x[xl] = y[yl] = '\0';
+    sprintf(expect + el, " ~\n");
+    check_diff(x, y, expect);
+}
+
+// --- Compressed input pipeline ---
+
+// Feeds `doc` to the stream parser split at `cut`, or one byte at a time when `cut` is 0
+static struct json_value_t *parse_split(const char *doc, size_t len, size_t cut) {
+    struct stream_scan_t scan;
+    stream_init(&scan);
+    bool ok = true;
+    if (cut == 0) {
+        for (size_t i = 0; ok && i < len; i++) ok = stream_feed(&scan, doc + i, 1);
+    } else {
+        ok = stream_feed(&scan, doc, cut) && stream_feed(&scan, doc + cut, len - cut);
+    }
+    struct json_value_t *root = ok ? stream_finish(&scan) : NULL;
+    stream_free(&scan);
+    return root;
+}
+
+// Every block boundary gives the same result as parse_json: the same tree, or a rejection
+static void test_stream_splits(void) {
+    static const char *docs[] = {
+        "{\"a\":[1,-2.5e+3,true,false,null],\"b\":{\"c\":\"d\"},\"e\":[],\"f\":{}}",
+        "[\"esc \\\" \\\\ \\/ \\n \\t \\u00e9 end\", \"\", \"\\u0041\\u0042\"]",
+        "/* lead */ { // line\n \"k\" /* mid */ : /**/ [ 1 , 2 ] // tail\n }",
+        "[true,false,null,truex]",
+        "12345.678e-2",
+        "\"top level\"",
+        "  null  ",
+        "{\"dup\":1,\"dup\":2}",
+        "[[[[[]]]],{\"a\":{\"b\":{\"c\":[0]}}}]",
+        // Rejected documents
+        "[1,]", "{\"a\" 1}", "[1 2]", "{\"a\":1]", "tru", "/x 1", "[1,2", "\"abc", "{,}", "", "   ", "[/]",
+    };
+    for (size_t d = 0; d < sizeof(docs) / sizeof(docs[0]); d++) {
+        const char *doc = docs[d];
+        size_t len = strlen(doc);
+        char err[256];
+        struct json_value_t *expect = parse_json(doc, len, err);
+
+        for (size_t cut = 0; cut <= len; cut++) {
+            struct json_value_t *got = parse_split(doc, len, cut);
+            bool ok = expect ? json_equal(expect, got) : got == NULL;
+            if (!ok) {
+                fprintf(stderr, "stream split at %zu of %s: %s\n", cut, doc, expect ? (got ? "tree differs" : "rejected") : "accepted");
+                failures++;
+            }
+            free(got);
+        }
+        free(expect);
+    }
+}
+
+
+// A valid document of exactly `size` bytes that exercises strings, escapes, comments and literals
+static char *make_doc(size_t size, unsigned seed) {
+    static const char *items[] = {
+        "\"plain\"", "\"esc \\\" \\\\ \\n \\t\"", "true", "false", "null", "-12.5e3", "0",
+        "{\"k\":[1,2,{\"z\":null}],\"s\":\"v\"}", "[]", "{}", "/* block * comment */ 7", "// line\n 8",
+    };
+    char *doc = malloc(size + 1);
+    size_t len = 0;
+    doc[len++] = '[';
+    bool first = true;
+    while (len + 64 < size) {
+        seed = seed * 1103515245u + 12345u;
+        const char *item = items[(seed >> 16) % (sizeof(items) / sizeof(items[0]))];
+        if (!first) doc[len++] = ',';
+        len += (size_t)sprintf(doc + len, "%s", item);
+        first = false;
+    }
+    while (len + 1 < size) doc[len++] = ' ';
+    doc[len++] = ']';
+    doc[len] = '\0';
+    return doc;
+}
+
+static struct json_value_t *parse_stream(const void *data, size_t len, enum json_codec_t codec, char *err) {
+    FILE *fp = tmpfile();
+    fwrite(data, 1, len, fp);
+    rewind(fp);
+    struct json_value_t *root = parse_json_compressed(fp, codec, err);
+    fclose(fp);
+    return root;
+}
+
+// Streams `data` and checks the result is the same tree as `expect`, or fails if `expect` is NULL
+static void check_stream(const struct json_value_t *expect, const void *data, size_t len, enum json_codec_t codec, const char *what, size_t size) {
+    char err[256] = "";
+    struct json_value_t *got = parse_stream(data, len, codec, err);
+    bool ok = expect ? json_equal(expect, got) : got == NULL;
+    if (!ok) {
+        fprintf(stderr, "%s, %zu byte document: %s (%s)\n", what, size, expect ? "tree differs" : "unexpectedly parsed", err);
+        failures++;
+    }
+    free(got);
+}
+
+#ifdef JSON_WITH_ZLIB
+static size_t gzip_into(const char *src, size_t len, unsigned char *dst, size_t cap) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY); // +16: gzip wrapper
+    zs.next_in = (Bytef *)src;
+    zs.avail_in = (uInt)len;
+    zs.next_out = dst;
+    zs.avail_out = (uInt)cap;
+    int rc = deflate(&zs, Z_FINISH);
+    CHECK(rc == Z_STREAM_END);
+    size_t n = zs.total_out;
+    deflateEnd(&zs);
+    return n;
+}
+#endif
+
+#ifdef JSON_WITH_ZSTD
+static size_t zstd_into(const char *src, size_t len, unsigned char *dst, size_t cap) {
+    size_t n = ZSTD_compress(dst, cap, src, len, 3);
+    CHECK(!ZSTD_isError(n));
+    return n;
+}
+#endif
+
+#if defined(JSON_WITH_ZLIB) || defined(JSON_WITH_ZSTD)
+typedef size_t (*compress_fn)(const char *src, size_t len, unsigned char *dst, size_t cap);
+
+// Single stream, two concatenated members/frames, truncated, corrupt
+static void check_codec(const char *doc, size_t size, const struct json_value_t *expect,
+                        compress_fn compress, enum json_codec_t codec, const char *name) {
+    size_t cap = size * 2 + 1024;
+    unsigned char *buf = malloc(cap);
+    char what[64];
+
+    size_t n = compress(doc, size, buf, cap);
+    snprintf(what, sizeof(what), "%s (sniffed)", name);
+    check_stream(expect, buf, n, JSON_CODEC_AUTO, what, size);
+    snprintf(what, sizeof(what), "%s (forced)", name);
+    check_stream(expect, buf, n, codec, what, size);
+
+    snprintf(what, sizeof(what), "%s truncated", name);
+    check_stream(NULL, buf, n - 5, JSON_CODEC_AUTO, what, size);
+
+    unsigned char *bad = malloc(n);
+    memcpy(bad, buf, n);
+    for (size_t i = n / 3; i < n / 3 + 16 && i < n; i++) bad[i] ^= 0x5a;
+    snprintf(what, sizeof(what), "%s corrupt", name);
+    check_stream(NULL, bad, n, JSON_CODEC_AUTO, what, size);
+    free(bad);
+
+    size_t half = size / 2;
+    size_t m = compress(doc, half, buf, cap);
+    m += compress(doc + half, size - half, buf + m, cap - m);
+    snprintf(what, sizeof(what), "%s two parts", name);
+    check_stream(expect, buf, m, JSON_CODEC_AUTO, what, size);
+
+    free(buf);
+}
+#endif
+
+static void test_compressed(void) {
+    // Sizes straddle the 64 KiB block, including exact multiples
+    static const size_t sizes[] = {
+        2, 100, JSON_BLOCK_SIZE - 1, JSON_BLOCK_SIZE, JSON_BLOCK_SIZE + 1,
+        2 * JSON_BLOCK_SIZE, 2 * JSON_BLOCK_SIZE + 7, 5 * JSON_BLOCK_SIZE, 700000,
+    };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t size = sizes[i];
+        char *doc = make_doc(size, (unsigned)i + 1);
+        CHECK(strlen(doc) == size);
+        char err[256];
+        struct json_value_t *expect = parse_json(doc, size, err);
+        CHECK(expect != NULL);
+
+        check_stream(expect, doc, size, JSON_CODEC_AUTO, "plain", size);
+        check_stream(expect, doc, size, JSON_CODEC_NONE, "plain (forced)", size);
+#ifdef JSON_WITH_ZLIB
+        check_codec(doc, size, expect, gzip_into, JSON_CODEC_GZIP, "gzip");
+#endif
+#ifdef JSON_WITH_ZSTD
+        check_codec(doc, size, expect, zstd_into, JSON_CODEC_ZSTD, "zstd");
+#endif
+        free(expect);
+        free(doc);
+    }
+
+    // Syntax errors: empty input, a cut-off document, and an early error with a lot of input
+    // still queued, which makes the parser abort the decompressor while it waits on a full ring
+    check_stream(NULL, "", 0, JSON_CODEC_AUTO, "empty", 0);
+    check_stream(NULL, "[1,2", 4, JSON_CODEC_AUTO, "unterminated", 4);
+    size_t size = 4 * 1024 * 1024;
+    char *doc = make_doc(size, 99);
+    doc[1] = '}';
+    check_stream(NULL, doc, size, JSON_CODEC_AUTO, "early error", size);
+#ifdef JSON_WITH_ZLIB
+    unsigned char *buf = malloc(size + 1024);
+    size_t n = gzip_into(doc, size, buf, size + 1024);
+    check_stream(NULL, buf, n, JSON_CODEC_AUTO, "gzip early error", size);
+    free(buf);
+#endif
+    free(doc);
+
+#ifndef JSON_WITH_ZLIB
+    check_stream(NULL, "\x1f\x8b\x08\x00", 4, JSON_CODEC_AUTO, "gzip without zlib", 4);
+#endif
+}
+
+int main(void) {
+    test_equal();
+    test_hash_pruning();
+    test_diff();
+    test_stream_splits();
+    test_compressed();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All tests passed\n");
+    return 0;
+}